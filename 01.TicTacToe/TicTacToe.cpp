@@ -1,9 +1,86 @@
 #include <bits/stdc++.h>
 using namespace std;
 
+/**
+ * @class ObjectPool
+ * @brief Recycles memory blocks for objects of one type.
+ *
+ * Each thread keeps its own free list of up to MAX_FREE blocks, so creating
+ * and destroying games neither takes a lock nor, once warmed up, reaches the
+ * global allocator. Blocks beyond that, and a thread's list when it exits,
+ * go back to the global allocator. Every block comes from ::operator new,
+ * so an object may be freed on a different thread than created it.
+ *
+ * Classes opt in by forwarding their operator new / delete to
+ * ObjectPool<Class>::allocate / deallocate.
+ */
+template <class T>
+class ObjectPool {
+private:
+    static const size_t MAX_FREE = 256;  ///< Spare blocks kept per thread
+
+    struct Block {
+        Block* next;
+    };
+
+    static constexpr size_t BLOCK = max(sizeof(T), sizeof(Block));  ///< Bytes per block (room for the link)
+
+    Block* freeList = nullptr;
+    size_t freeCount = 0;
+
+    ObjectPool() = default;
+
+public:
+    ~ObjectPool() {
+        while (freeList) {
+            Block* b = freeList;
+            freeList = b->next;
+            ::operator delete(b);
+        }
+        freeCount = MAX_FREE;  // objects freed later in this thread's exit go straight to the global allocator
+    }
+
+    /**
+     * @brief Get the calling thread's pool of this type.
+     * @return ObjectPool& The pool.
+     */
+    static ObjectPool& instance() {
+        static thread_local ObjectPool pool;
+        return pool;
+    }
+
+    /**
+     * @brief Get memory for one object.
+     * @param size Requested size; anything but sizeof(T) (a derived class) goes to the global allocator.
+     * @return void* The memory.
+     */
+    void* allocate(size_t size) {
+        if (size != sizeof(T)) return ::operator new(size);
+        if (!freeList) return ::operator new(BLOCK);
+        Block* b = freeList;
+        freeList = b->next;
+        freeCount--;
+        return b;
+    }
+
+    /**
+     * @brief Return memory obtained from allocate() (on any thread).
+     * @param p The memory.
+     * @param size The size passed to allocate().
+     */
+    void deallocate(void* p, size_t size) {
+        if (!p) return;
+        if (size != sizeof(T) || freeCount >= MAX_FREE) return ::operator delete(p);
+        Block* b = static_cast<Block*>(p);
+        b->next = freeList;
+        freeList = b;
+        freeCount++;
+    }
+};
+
 /**
  * @class IObserver
- * @brief Interface for observer pattern (not used in current implementation).
+ * @brief Interface for observer pattern; TicTacToe::applyMove() notifies observers when a game is won or drawn.
  */
 class IObserver {
 public:
@@ -30,6 +107,14 @@ public:
      */
     explicit Symbol(char m) : mark(m) {}
 
+    static void* operator new(size_t size) {
+        return ObjectPool<Symbol>::instance().allocate(size);
+    }
+
+    static void operator delete(void* p, size_t size) {
+        ObjectPool<Symbol>::instance().deallocate(p, size);
+    }
+
     /**
      * @brief Get the character representing the symbol.
      * @return char The symbol character.
@@ -39,6 +124,58 @@ public:
     }
 };
 
+/**
+ * @class GridPool
+ * @brief Keeps the cell grids of destroyed Boards for new Boards of the same size.
+ *
+ * Like ObjectPool, each thread has its own pool; it keeps at most MAX_SPARE
+ * grids over all sizes and frees any grid released beyond that.
+ */
+class GridPool {
+private:
+    typedef vector<vector<Symbol*>> Grid;
+
+    static const size_t MAX_SPARE = 16;  ///< Spare grids kept per thread
+
+    map<int, vector<Grid>> freeGrids;  ///< Spare grids by board size (no empty entries)
+    size_t spare = 0;                  ///< Grids in freeGrids
+
+public:
+    /**
+     * @brief Get the calling thread's pool.
+     * @return GridPool& The pool.
+     */
+    static GridPool& instance() {
+        static thread_local GridPool pool;
+        return pool;
+    }
+
+    /**
+     * @brief Get a size x size grid, reusing a released one if possible (cells are unspecified).
+     * @param size The board size.
+     * @return Grid The grid.
+     */
+    Grid acquire(int size) {
+        auto it = freeGrids.find(size);
+        if (it == freeGrids.end()) return Grid(size, vector<Symbol*>(size, nullptr));
+        Grid grid = move(it->second.back());
+        it->second.pop_back();
+        if (it->second.empty()) freeGrids.erase(it);
+        spare--;
+        return grid;
+    }
+
+    /**
+     * @brief Give a grid back for reuse (it is freed if the pool is full).
+     * @param grid The grid.
+     */
+    void release(Grid&& grid) {
+        if (spare >= MAX_SPARE) return;
+        freeGrids[(int)grid.size()].push_back(move(grid));
+        spare++;
+    }
+};
+
 /**
  * @class Board
  * @brief Represents the Tic Tac Toe board and manages game state.
@@ -54,19 +191,27 @@ public:
      * @brief Construct a Board of given size.
      * @param size The board size (n x n).
      */
-    explicit Board(int size)
-        : size(size), emptySymbol(new Symbol(' ')), grid(size, vector<Symbol*>(size, nullptr)) {
+    explicit Board(int size) : grid(GridPool::instance().acquire(size)), size(size), emptySymbol(new Symbol(' ')) {
         for (int i = 0; i < size; ++i)
             for (int j = 0; j < size; ++j) grid[i][j] = emptySymbol;
     }
 
     /**
-     * @brief Destructor to clean up resources.
+     * @brief Destructor to clean up resources; the grid is kept for the next board of this size.
      */
     ~Board() {
+        GridPool::instance().release(move(grid));
         delete emptySymbol;
     }
 
+    static void* operator new(size_t size) {
+        return ObjectPool<Board>::instance().allocate(size);
+    }
+
+    static void operator delete(void* p, size_t size) {
+        ObjectPool<Board>::instance().deallocate(p, size);
+    }
+
     /**
      * @brief Check if a cell is empty.
      * @param row Row index.
@@ -138,16 +283,19 @@ public:
     }
 };
 
+class BotStrategy;
+
 /**
  * @class Player
  * @brief Represents a player in the game, holding their ID, name, symbol, and score.
  */
 class Player {
 private:
-    int id;       ///< Player ID
-    string name;  ///< Player name
-    Symbol* s;    ///< Player symbol
-    int score;    ///< Player score
+    int id;                      ///< Player ID
+    string name;                 ///< Player name
+    Symbol* s;                   ///< Player symbol
+    int score;                   ///< Player score
+    BotStrategy* bot = nullptr;  ///< Computer strategy playing this seat (not owned), nullptr for a human
 
 public:
     /**
@@ -158,6 +306,14 @@ public:
      */
     Player(int playerId, string n, Symbol* sym) : id(playerId), name(n), s(sym), score(0) {}
 
+    static void* operator new(size_t size) {
+        return ObjectPool<Player>::instance().allocate(size);
+    }
+
+    static void operator delete(void* p, size_t size) {
+        ObjectPool<Player>::instance().deallocate(p, size);
+    }
+
     /**
      * @brief Get the player's name.
      * @return string The player's name.
@@ -182,6 +338,22 @@ public:
         return score;
     }
 
+    /**
+     * @brief Let a computer strategy play for this player.
+     * @param b The strategy (not owned), or nullptr for a human.
+     */
+    void setBot(BotStrategy* b) {
+        bot = b;
+    }
+
+    /**
+     * @brief Get the computer strategy playing for this player.
+     * @return BotStrategy* The strategy, or nullptr for a human.
+     */
+    BotStrategy* getBot() const {
+        return bot;
+    }
+
     /**
      * @brief Destructor to clean up the symbol object.
      */
@@ -235,6 +407,14 @@ public:
      */
     explicit StandardRule(Board* b) : board(b) {}
 
+    static void* operator new(size_t size) {
+        return ObjectPool<StandardRule>::instance().allocate(size);
+    }
+
+    static void operator delete(void* p, size_t size) {
+        ObjectPool<StandardRule>::instance().deallocate(p, size);
+    }
+
     /**
      * @brief Check for a winning condition for the symbol s.
      * @param s The symbol to check for a win.
@@ -288,9 +468,418 @@ public:
     }
 };
 
+/**
+ * @class BotStrategy
+ * @brief Interface for computer players.
+ */
+class BotStrategy {
+public:
+    /**
+     * @brief Choose a move for the player to move.
+     * @param board The current board.
+     * @param players All players, in turn order.
+     * @param current Index of the player to move.
+     * @return pair<int, int> Row and column of the chosen cell.
+     */
+    virtual pair<int, int> chooseMove(const Board& board, const deque<Player*>& players, int current) = 0;
+
+    virtual ~BotStrategy() = default;
+};
+
+/**
+ * @class SearchCache
+ * @brief Fixed-size transposition table that several MultiPlayerBots can share.
+ *
+ * Entries hold a payoff per player (or one scalar for paranoid search) with
+ * its search depth and bound. Slots are guarded by a small set of striped
+ * locks, so bots of different games may probe it concurrently.
+ */
+class SearchCache {
+public:
+    static const int MAX_PLAYERS = 8;  ///< Larger games are searched without the cache
+
+    enum Bound : uint8_t { NONE, EXACT, LOWER, UPPER };
+
+    struct Entry {
+        uint64_t key = 0;
+        int depth = -1;
+        Bound bound = NONE;
+        int move = -1;                        ///< Best cell index (row * size + col), -1 if none
+        array<float, MAX_PLAYERS> payoff{};  ///< Per player; paranoid search uses payoff[0]
+    };
+
+private:
+    vector<Entry> entries;
+    array<mutex, 64> locks;
+
+public:
+    /**
+     * @brief Construct a cache with a fixed number of slots.
+     * @param slots Number of entries.
+     */
+    explicit SearchCache(size_t slots = 1 << 18) : entries(slots) {}
+
+    /**
+     * @brief Look up a position.
+     * @param key Position key.
+     * @param out Receives the entry on a hit.
+     * @return bool True on a hit.
+     */
+    bool probe(uint64_t key, Entry& out) {
+        size_t i = key % entries.size();
+        lock_guard<mutex> lock(locks[i % locks.size()]);
+        if (entries[i].key != key || entries[i].bound == NONE) return false;
+        out = entries[i];
+        return true;
+    }
+
+    /**
+     * @brief Store a result, keeping a deeper result for the same position.
+     * @param e The entry to store.
+     */
+    void store(const Entry& e) {
+        size_t i = e.key % entries.size();
+        lock_guard<mutex> lock(locks[i % locks.size()]);
+        if (entries[i].key != e.key || e.depth >= entries[i].depth) entries[i] = e;
+    }
+};
+
+/**
+ * @class MultiPlayerBot
+ * @brief Computer player for games with any number of players.
+ *
+ * Searches with iterative deepening until a time limit, in one of two modes:
+ *  - MAXN: every player maximizes its own entry of a payoff vector. Payoffs
+ *    always sum to 1, which allows shallow pruning: once the player to move
+ *    is sure of more than 1 - (what the previous player already has
+ *    elsewhere), the previous player will not come here.
+ *  - PARANOID: all other players are assumed to minimize the bot's payoff,
+ *    which turns the game into a two-sided alpha-beta search.
+ *
+ * Payoffs: a win is worth 1 (slightly less the more stones are on the
+ * board, so the value depends on the position alone and can be cached), a
+ * draw 1/P each; at the depth limit every player gets a share proportional to
+ * 1 + sum of 4^stones over the lines only that player occupies.
+ */
+class MultiPlayerBot : public BotStrategy {
+public:
+    enum Mode { MAXN, PARANOID };
+
+private:
+    Mode mode;
+    SearchCache* cache;  ///< Shared cache (not owned), may be nullptr
+    int timeMs;
+    int maxDepth;
+
+    int n = 0, playerCount = 0, root = 0, empties = 0;
+    vector<int> cells;  ///< Player index per cell, -1 if empty
+    vector<int> order;  ///< Cells sorted center first
+    uint64_t hash = 0;
+    uint64_t nodes = 0;
+    bool timeUp = false;
+    chrono::steady_clock::time_point deadline;
+
+    static uint64_t mix(uint64_t x) {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    static uint64_t cellKey(int cell, int player) {
+        return mix((uint64_t)cell * 64 + player + 1);
+    }
+
+    uint64_t key(int toMove) const {
+        uint64_t k = hash ^ mix(0x7000 + toMove) ^ mix(0x8000 + playerCount) ^ mix(0xA000 + n);
+        return mode == PARANOID ? k ^ mix(0x9000 + root) : k;
+    }
+
+    /**
+     * @brief Check that a cache entry's move is an empty cell of this board (guards against key collisions).
+     * @param e The entry.
+     * @return bool True if the entry may be used.
+     */
+    bool usable(const SearchCache::Entry& e) const {
+        return e.move >= 0 && e.move < n * n && cells[e.move] < 0;
+    }
+
+    bool outOfTime() {
+        if (!timeUp && (++nodes & 1023) == 0 && chrono::steady_clock::now() > deadline) timeUp = true;
+        return timeUp;
+    }
+
+    void place(int cell, int player) {
+        cells[cell] = player;
+        hash ^= cellKey(cell, player);
+        empties--;
+    }
+
+    void unplace(int cell) {
+        hash ^= cellKey(cell, cells[cell]);
+        cells[cell] = -1;
+        empties++;
+    }
+
+    bool completesLine(int cell) const {
+        int r = cell / n, c = cell % n, p = cells[cell];
+        bool row = true, col = true, diag = r == c, anti = r + c == n - 1;
+        for (int i = 0; i < n; i++) {
+            row = row && cells[r * n + i] == p;
+            col = col && cells[i * n + c] == p;
+            diag = diag && cells[i * n + i] == p;
+            anti = anti && cells[i * n + n - 1 - i] == p;
+        }
+        return row || col || diag || anti;
+    }
+
+    vector<double> terminal(int winner) const {
+        if (winner < 0) return vector<double>(playerCount, 1.0 / playerCount);
+        double delay = min(0.5, (n * n - empties) * 0.001);  // prefer quicker wins, keeping the sum at 1
+        if (playerCount < 2) return vector<double>(playerCount, 1 - delay);  // a lone player has nobody to share with
+        vector<double> v(playerCount, delay / (playerCount - 1));
+        v[winner] = 1 - delay;
+        return v;
+    }
+
+    vector<double> evaluate() const {
+        vector<double> strength(playerCount, 1.0);
+        auto line = [&](int start, int step) {
+            int owner = -1, stones = 0;
+            for (int i = 0; i < n; i++) {
+                int p = cells[start + i * step];
+                if (p < 0) continue;
+                if (owner >= 0 && p != owner) return;
+                owner = p;
+                stones++;
+            }
+            if (owner >= 0) strength[owner] += ldexp(1.0, 2 * stones);
+        };
+        for (int i = 0; i < n; i++) {
+            line(i * n, 1);
+            line(i, n);
+        }
+        line(0, n + 1);
+        line(n - 1, n - 1);
+        double total = accumulate(strength.begin(), strength.end(), 0.0);
+        for (double& v : strength) v /= total;
+        return strength;
+    }
+
+    /**
+     * @brief Max^n search with shallow pruning.
+     * @param toMove Player to move.
+     * @param depth Remaining depth.
+     * @param parentBest Payoff the previous player is already sure of (-1 for none).
+     * @param bestMove Receives the best cell.
+     * @param exact Set to false if the result is only a bound (subtree was pruned).
+     * @return vector<double> Payoff of every player.
+     */
+    vector<double> maxn(int toMove, int depth, double parentBest, int& bestMove, bool& exact) {
+        exact = true;
+        bestMove = -1;
+        if (outOfTime()) return vector<double>(playerCount, 0.0);
+        if (depth == 0) return evaluate();
+
+        bool cached = cache && playerCount <= SearchCache::MAX_PLAYERS;
+        SearchCache::Entry e;
+        int hashMove = -1;
+        if (cached && cache->probe(key(toMove), e) && usable(e)) {
+            hashMove = e.move;
+            if (e.depth >= depth && e.bound == SearchCache::EXACT) {
+                bestMove = e.move;
+                return vector<double>(e.payoff.begin(), e.payoff.begin() + playerCount);
+            }
+        }
+
+        vector<double> best(playerCount, -1.0);
+        int next = (toMove + 1) % playerCount;
+        bool pruned = false;
+        for (int i = -1; i < n * n; i++) {
+            int cell = i < 0 ? hashMove : order[i];
+            if (cell < 0 || cells[cell] >= 0 || (i >= 0 && cell == hashMove)) continue;
+            place(cell, toMove);
+            vector<double> v;
+            bool childExact = true;
+            int childMove;
+            if (completesLine(cell))
+                v = terminal(toMove);
+            else if (empties == 0)
+                v = terminal(-1);
+            else
+                v = maxn(next, depth - 1, best[toMove], childMove, childExact);
+            unplace(cell);
+            if (timeUp) return best;
+            exact = exact && childExact;
+            if (bestMove < 0 || v[toMove] > best[toMove]) {
+                best = v;
+                bestMove = cell;
+            }
+            if (best[toMove] >= 1 - parentBest) {  // the previous player gets at most parentBest here
+                pruned = true;
+                break;
+            }
+        }
+        exact = exact && !pruned;
+        if (cached && exact) {
+            e = SearchCache::Entry();
+            e.key = key(toMove);
+            e.depth = depth;
+            e.bound = SearchCache::EXACT;
+            e.move = bestMove;
+            for (int p = 0; p < playerCount; p++) e.payoff[p] = (float)best[p];
+            cache->store(e);
+        }
+        return best;
+    }
+
+    /**
+     * @brief Paranoid alpha-beta search of the root player's payoff.
+     * @param toMove Player to move.
+     * @param depth Remaining depth.
+     * @param alpha Lower bound of the window.
+     * @param beta Upper bound of the window.
+     * @param bestMove Receives the best cell.
+     * @return double Payoff of the root player.
+     */
+    double paranoid(int toMove, int depth, double alpha, double beta, int& bestMove) {
+        bestMove = -1;
+        if (outOfTime()) return 0;
+        if (depth == 0) return evaluate()[root];
+
+        SearchCache::Entry e;
+        int hashMove = -1;
+        if (cache && cache->probe(key(toMove), e) && usable(e)) {
+            hashMove = e.move;
+            if (e.depth >= depth) {
+                double v = e.payoff[0];
+                if (e.bound == SearchCache::EXACT || (e.bound == SearchCache::LOWER && v >= beta) ||
+                    (e.bound == SearchCache::UPPER && v <= alpha)) {
+                    bestMove = e.move;
+                    return v;
+                }
+            }
+        }
+
+        bool maximizing = toMove == root;
+        double alphaOrig = alpha, betaOrig = beta, best = maximizing ? -1 : 2;
+        int next = (toMove + 1) % playerCount;
+        for (int i = -1; i < n * n; i++) {
+            int cell = i < 0 ? hashMove : order[i];
+            if (cell < 0 || cells[cell] >= 0 || (i >= 0 && cell == hashMove)) continue;
+            place(cell, toMove);
+            double v;
+            int childMove;
+            if (completesLine(cell))
+                v = terminal(toMove)[root];
+            else if (empties == 0)
+                v = terminal(-1)[root];
+            else
+                v = paranoid(next, depth - 1, alpha, beta, childMove);
+            unplace(cell);
+            if (timeUp) return best;
+            if (maximizing ? v > best : v < best) {
+                best = v;
+                bestMove = cell;
+            }
+            if (maximizing)
+                alpha = max(alpha, best);
+            else
+                beta = min(beta, best);
+            if (alpha >= beta) break;
+        }
+        if (cache) {
+            e = SearchCache::Entry();
+            e.key = key(toMove);
+            e.depth = depth;
+            e.bound = best <= alphaOrig ? SearchCache::UPPER : best >= betaOrig ? SearchCache::LOWER : SearchCache::EXACT;
+            e.move = bestMove;
+            e.payoff[0] = (float)best;
+            cache->store(e);
+        }
+        return best;
+    }
+
+public:
+    /**
+     * @brief Construct a multi-player bot.
+     * @param m Search mode.
+     * @param c Cache to share with other bots (not owned), or nullptr.
+     * @param moveTimeMs Time limit per move in milliseconds.
+     * @param depthLimit Maximum search depth in plies.
+     */
+    MultiPlayerBot(Mode m, SearchCache* c = nullptr, int moveTimeMs = 200, int depthLimit = 64)
+        : mode(m), cache(c), timeMs(moveTimeMs), maxDepth(depthLimit) {}
+
+    /**
+     * @brief Choose a move by iterative deepening until the time limit.
+     * @param board The current board.
+     * @param players All players, in turn order.
+     * @param current Index of the player to move.
+     * @return pair<int, int> Row and column of the chosen cell.
+     */
+    pair<int, int> chooseMove(const Board& board, const deque<Player*>& players, int current) override {
+        n = board.getSize();
+        playerCount = (int)players.size();
+        root = current;
+        cells.assign(n * n, -1);
+        hash = 0;
+        empties = n * n;
+        for (int r = 0; r < n; r++)
+            for (int c = 0; c < n; c++)
+                for (int p = 0; p < playerCount; p++)
+                    if (players[p]->getSymbol() == board.getCell(r, c)) place(r * n + c, p);
+        order.resize(n * n);
+        iota(order.begin(), order.end(), 0);
+        double mid = (n - 1) / 2.0;
+        stable_sort(order.begin(), order.end(), [&](int a, int b) {
+            return fabs(a / n - mid) + fabs(a % n - mid) < fabs(b / n - mid) + fabs(b % n - mid);
+        });
+
+        deadline = chrono::steady_clock::now() + chrono::milliseconds(timeMs);
+        timeUp = false;
+        nodes = 0;
+        int move = -1;
+        for (int depth = 1; depth <= min(maxDepth, empties); depth++) {
+            int found;
+            if (mode == MAXN) {
+                bool exact;
+                maxn(root, depth, -1.0, found, exact);
+            } else {
+                paranoid(root, depth, -1.0, 2.0, found);
+            }
+            if (timeUp) break;
+            move = found;
+        }
+        if (move < 0)
+            for (int cell : order)
+                if (cells[cell] < 0) {
+                    move = cell;
+                    break;
+                }
+        return {move / n, move % n};
+    }
+};
+
+/**
+ * @enum MoveResult
+ * @brief Outcome of TicTacToe::applyMove.
+ */
+enum MoveResult { MOVE_OK, MOVE_WIN, MOVE_DRAW, MOVE_INVALID, MOVE_NOT_YOUR_TURN, MOVE_GAME_OVER };
+
+/**
+ * @enum GameStatus
+ * @brief State of a TicTacToe game.
+ */
+enum GameStatus { IN_PROGRESS, WON, DRAWN };
+
 /**
  * @class TicTacToe
  * @brief Manages the game flow, player turns, and game state.
+ *
+ * Moves are submitted with applyMove(), which never blocks, so a host can
+ * drive any number of games from its own loop; play() is a console driver
+ * on top of it.
  */
 class TicTacToe {
 private:
@@ -299,6 +888,8 @@ private:
     Rule* rule;                    ///< Pointer to the game rule
     vector<IObserver*> observers;  ///< List of observers
     bool gameOver;                 ///< Game over flag
+    int currentPlayerIndex;        ///< Index of the player to move
+    Player* winner;                ///< Winning player, nullptr if none
 
 public:
     /**
@@ -306,7 +897,15 @@ public:
      * @param b Pointer to the board.
      * @param r Pointer to the rule.
      */
-    TicTacToe(Board* b, Rule* r) : board(b), rule(r), gameOver(false) {}
+    TicTacToe(Board* b, Rule* r) : board(b), rule(r), gameOver(false), currentPlayerIndex(0), winner(nullptr) {}
+
+    static void* operator new(size_t size) {
+        return ObjectPool<TicTacToe>::instance().allocate(size);
+    }
+
+    static void operator delete(void* p, size_t size) {
+        ObjectPool<TicTacToe>::instance().deallocate(p, size);
+    }
 
     /**
      * @brief Add a player to the game.
@@ -333,38 +932,115 @@ public:
     }
 
     /**
-     * @brief Start and manage the game play.
+     * @brief Get the player whose turn it is.
+     * @return Player* The player to move, or nullptr if there are no players.
+     */
+    Player* currentPlayer() const {
+        return players.empty() ? nullptr : players[currentPlayerIndex];
+    }
+
+    /**
+     * @brief Get the game status.
+     * @return GameStatus IN_PROGRESS, WON or DRAWN.
+     */
+    GameStatus status() const {
+        if (!gameOver) return IN_PROGRESS;
+        return winner ? WON : DRAWN;
+    }
+
+    /**
+     * @brief Get the winner.
+     * @return Player* The winning player, or nullptr if nobody has won.
+     */
+    Player* getWinner() const {
+        return winner;
+    }
+
+    /**
+     * @brief Get the board.
+     * @return const Board& The game board.
+     */
+    const Board& getBoard() const {
+        return *board;
+    }
+
+    /**
+     * @brief Get the players in turn order.
+     * @return const deque<Player*>& The players.
+     */
+    const deque<Player*>& getPlayers() const {
+        return players;
+    }
+
+    /**
+     * @brief Play a move for a player and advance the turn.
+     * @param player The player making the move.
+     * @param row Row index.
+     * @param col Column index.
+     * @return MoveResult MOVE_OK, MOVE_WIN or MOVE_DRAW if the move was played,
+     *         otherwise why it was rejected.
+     */
+    MoveResult applyMove(Player* player, int row, int col) {
+        if (gameOver) return MOVE_GAME_OVER;
+        if (player != currentPlayer()) return MOVE_NOT_YOUR_TURN;
+        if (!rule->isValidMove(row, col)) return MOVE_INVALID;
+
+        board->markCell(row, col, player->getSymbol());
+        if (rule->checkWin(player->getSymbol())) {
+            gameOver = true;
+            winner = player;
+            notify(player->getName() + " wins!");
+            return MOVE_WIN;
+        }
+        if (rule->checkDraw()) {
+            gameOver = true;
+            notify("It's a draw!");
+            return MOVE_DRAW;
+        }
+        currentPlayerIndex = (currentPlayerIndex + 1) % players.size();
+        return MOVE_OK;
+    }
+
+    /**
+     * @brief Start and manage the game play on the console.
+     *
+     * The result is announced to the observers, or printed here if none are registered.
      */
     void play() {
-        int currentPlayerIndex = 0;
         board->display();
 
-        while (!gameOver) {
-            Player* currentPlayer = players[currentPlayerIndex];
+        while (status() == IN_PROGRESS) {
+            Player* player = currentPlayer();
+            if (!player) {
+                cout << "No players have joined.\n";
+                return;
+            }
             int row, col;
 
-            cout << currentPlayer->getName() << "'s turn (" << currentPlayer->getSymbol()->getMark()
-                 << "). Enter row and column: ";
-            cin >> row >> col;
+            if (player->getBot()) {
+                tie(row, col) = player->getBot()->chooseMove(*board, players, currentPlayerIndex);
+                cout << player->getName() << " (" << player->getSymbol()->getMark() << ") plays " << row << " " << col
+                     << "\n";
+            } else {
+                cout << player->getName() << "'s turn (" << player->getSymbol()->getMark()
+                     << "). Enter row and column: ";
+                if (!(cin >> row >> col)) return;
+            }
 
-            if (!rule->isValidMove(row, col)) {
+            MoveResult result = applyMove(player, row, col);
+            if (result == MOVE_INVALID && player->getBot()) {  // never ask a bot twice; take the first empty cell
+                int n = board->getSize();
+                for (int cell = 0; result == MOVE_INVALID && cell < n * n; cell++)
+                    result = applyMove(player, cell / n, cell % n);
+            }
+            if (result == MOVE_INVALID) {
                 cout << "Invalid move! Try again.\n";
                 continue;
             }
 
-            board->markCell(row, col, currentPlayer->getSymbol());
-            board->display();
-
-            if (rule->checkWin(currentPlayer->getSymbol())) {
-                cout << currentPlayer->getName() << " wins!\n";
-                gameOver = true;
-            } else if (rule->checkDraw()) {
-                cout << "It's a draw!\n";
-                gameOver = true;
-            } else {
-                currentPlayerIndex = (currentPlayerIndex + 1) % players.size();
-            }
+            board->display();  // applyMove() has told the observers if the game ended
         }
+        if (observers.empty()) cout << (winner ? winner->getName() + " wins!" : string("It's a draw!")) << "\n";
     }
 
     /**
@@ -386,6 +1062,10 @@ enum GameType { STANDARD };
 /**
  * @class GameFactory
  * @brief Factory for creating TicTacToe games.
+ *
+ * Games, boards, rules, players and symbols come from per-type ObjectPools
+ * and board grids from GridPool, so the plain new / delete used here and in
+ * the destructors mostly recycle memory instead of calling malloc / free.
  */
 class GameFactory {
 public:
@@ -406,6 +1086,124 @@ public:
     }
 };
 
+/**
+ * @class SessionManager
+ * @brief Registry of live games addressed by id.
+ *
+ * Ids pack a slot index (low 32 bits) with the slot's generation (high 32
+ * bits). Destroying a game bumps the generation, so ids of finished games
+ * never resolve to a game that later reuses the slot. A dense array of
+ * live slots gives cache-friendly iteration; create, get and destroy are
+ * O(1). Not thread-safe: one host loop owns a manager.
+ */
+class SessionManager {
+public:
+    typedef uint64_t SessionId;  ///< 0 is never a valid id
+
+private:
+    struct Slot {
+        TicTacToe* game = nullptr;
+        uint32_t generation = 1;
+        uint32_t denseIndex = 0;  ///< Position in live, valid while game != nullptr
+    };
+
+    vector<Slot> slots;
+    vector<uint32_t> freeSlots;  ///< Slots without a game
+    vector<uint32_t> live;       ///< Slots with a game, in no particular order
+
+    static SessionId makeId(uint32_t index, uint32_t generation) {
+        return (SessionId)generation << 32 | index;
+    }
+
+    Slot* find(SessionId id) {
+        uint32_t index = (uint32_t)id, generation = (uint32_t)(id >> 32);
+        if (index >= slots.size() || slots[index].generation != generation || !slots[index].game) return nullptr;
+        return &slots[index];
+    }
+
+public:
+    SessionManager() = default;
+    SessionManager(const SessionManager&) = delete;
+    SessionManager& operator=(const SessionManager&) = delete;
+
+    /**
+     * @brief Destructor to free every live game.
+     */
+    ~SessionManager() {
+        for (uint32_t index : live) delete slots[index].game;
+    }
+
+    /**
+     * @brief Create a game and register it.
+     * @param t The game type.
+     * @param size The board size.
+     * @return SessionId Id of the new game, or 0 if the factory could not create it.
+     */
+    SessionId create(GameType t, int size) {
+        TicTacToe* game = GameFactory::createGame(t, size);
+        if (!game) return 0;
+        uint32_t index;
+        if (!freeSlots.empty()) {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            index = (uint32_t)slots.size();
+            slots.emplace_back();
+        }
+        Slot& slot = slots[index];
+        slot.game = game;
+        slot.denseIndex = (uint32_t)live.size();
+        live.push_back(index);
+        return makeId(index, slot.generation);
+    }
+
+    /**
+     * @brief Look up a game.
+     * @param id The session id.
+     * @return TicTacToe* The game, or nullptr if the id is unknown or was destroyed.
+     */
+    TicTacToe* get(SessionId id) {
+        Slot* slot = find(id);
+        return slot ? slot->game : nullptr;
+    }
+
+    /**
+     * @brief Delete a game; its id (and any copy of it) becomes invalid.
+     * @param id The session id.
+     * @return bool True if a game was destroyed.
+     */
+    bool destroy(SessionId id) {
+        Slot* slot = find(id);
+        if (!slot) return false;
+        delete slot->game;
+        slot->game = nullptr;
+        slot->generation = slot->generation == UINT32_MAX ? 1 : slot->generation + 1;
+        uint32_t moved = live.back();  // swap-remove from the dense array
+        live[slot->denseIndex] = moved;
+        slots[moved].denseIndex = slot->denseIndex;
+        live.pop_back();
+        freeSlots.push_back((uint32_t)id);
+        return true;
+    }
+
+    /**
+     * @brief Get the number of live games.
+     * @return size_t The number of games.
+     */
+    size_t size() const {
+        return live.size();
+    }
+
+    /**
+     * @brief Call f(id, game) for every live game. f must not create or destroy games.
+     * @param f The callback.
+     */
+    template <class F>
+    void forEach(F f) {
+        for (uint32_t index : live) f(makeId(index, slots[index].generation), slots[index].game);
+    }
+};
+
 /**
  * @class ConsoleNotifier
  * @brief Observer for console notifications.
@@ -429,8 +1227,10 @@ int main() {
     cout << "Enter board size (e.g., 3 for 3x3): ";
     cin >> boardSize;
 
-    // Use GameFactory to create the game
-    TicTacToe* game = GameFactory::createGame(STANDARD, boardSize);
+    // Host the game in a session manager (which creates it through GameFactory)
+    SessionManager sessions;
+    SessionManager::SessionId id = sessions.create(STANDARD, boardSize);
+    TicTacToe* game = sessions.get(id);
 
     IObserver* notifier = new ConsoleNotifier();
     game->addObserver(notifier);
@@ -438,17 +1238,32 @@ int main() {
     // Test notifier
     game->notify("This is a test notification!");
 
-    // Create players
-    Player* player1 = new Player(1, "Player 1", new Symbol('X'));
-    Player* player2 = new Player(2, "Player 2", new Symbol('O'));
+    int playerCount, botCount;
+    cout << "Enter number of players (2 - 8): ";
+    cin >> playerCount;
+    playerCount = max(2, min(8, playerCount));
+    cout << "How many of them should the computer play? ";
+    cin >> botCount;
+    botCount = max(0, min(playerCount, botCount));
 
-    game->addPlayer(player1);
-    game->addPlayer(player2);
+    // Create players; computer players take the last seats and share one cache
+    const string marks = "XOABCDEF";
+    SearchCache cache;
+    vector<BotStrategy*> bots;
+    for (int i = 0; i < playerCount; i++) {
+        Player* player = new Player(i + 1, "Player " + to_string(i + 1), new Symbol(marks[i]));
+        if (i >= playerCount - botCount) {
+            bots.push_back(new MultiPlayerBot(playerCount > 2 ? MultiPlayerBot::MAXN : MultiPlayerBot::PARANOID, &cache));
+            player->setBot(bots.back());
+        }
+        game->addPlayer(player);
+    }
 
     game->play();
 
-    delete game;
+    sessions.destroy(id);
     delete notifier;
+    for (auto b : bots) delete b;
 
     return 0;
 }
\ No newline at end of file